@@ -22,5 +22,5 @@ else
     exit 0
 fi
 
-#eos v1.7.0
-cleos -u $url set contract $account ./build/$contract/ $contract.wasm $contract.abi -p $account
\ No newline at end of file
+#eos v1.7.0, WALLET_URL selects a keosd other than the default
+cleos -u $url ${WALLET_URL:+--wallet-url $WALLET_URL} set contract $account ./build/$contract/ $contract.wasm $contract.abi -p $account
\ No newline at end of file
@@ -34,35 +34,84 @@ public:
     // scope is self
     TABLE symbolinfo { //TODO: necessary?
         string symbol;
-        uint64_t global_id;
+        uint64_t global_id; //next global id to assign
+
+        EOSLIB_SERIALIZE(symbolinfo, (symbol)(global_id))
     };
 
     // scope is category, then token_name is unique
-    // TABLE tokenstats {
-    //     bool fungible; 
-    //     bool burnable; 
-    //     bool transferable; 
-    //     name issuer;
-    //     name token_name;
-    //     uint64_t global_id; //TODO: change to symbol type ?
-    //     uint64_t max_supply;
-    //     double current_supply;
-
-    //     uint64_t primary_key() const { return token_name.value; }
-    //     EOSLIB_SERIALIZE(tokenstats, (fungible)(burnable)(transferable)
-    //         (issuer)(token_name)(global_id)(max_supply)(current_supply))
-    // };
+    TABLE tokenstats {
+        bool fungible; 
+        bool burnable; 
+        bool transferable; 
+        name issuer;
+        name token_name;
+        uint64_t global_id; //TODO: change to symbol type ?
+        uint64_t max_supply;
+        double current_supply;
+        uint64_t next_serial; //first serial of the next issued nft range
+        string metadata_template; //every {serial} is replaced by the token's serial number
+
+        uint64_t primary_key() const { return token_name.value; }
+        EOSLIB_SERIALIZE(tokenstats, (fungible)(burnable)(transferable)
+            (issuer)(token_name)(global_id)(max_supply)(current_supply)(next_serial)
+            (metadata_template))
+    };
+
+    // scope is self
+    // owner holds every serial in [first_serial, last_serial], ranges are only
+    // split when individual serials are transferred or burned
+    TABLE tokenrange {
+        uint64_t id;
+        uint64_t global_id;
+        name owner;
+        uint64_t first_serial;
+        uint64_t last_serial;
+
+        uint64_t primary_key() const { return id; }
+        uint64_t get_owner() const { return owner.value; }
+        uint128_t by_serial() const { return (uint128_t(global_id) << 64) | last_serial; }
+        EOSLIB_SERIALIZE(tokenrange, (id)(global_id)(owner)(first_serial)(last_serial))
+    };
+
+    // scope is self
+    // replaces the token class metadata template for a single serial
+    TABLE metaoverride {
+        uint64_t id;
+        uint64_t global_id;
+        uint64_t serial_number;
+        string metadata_uri;
+
+        uint64_t primary_key() const { return id; }
+        uint128_t by_serial() const { return (uint128_t(global_id) << 64) | serial_number; }
+        EOSLIB_SERIALIZE(metaoverride, (id)(global_id)(serial_number)(metadata_uri))
+    };
 
     // typedef multi_index<name("accounts"), account> accounts;
 
     // typedef multi_index<name("categoryinfo"), categoryinfo> categoryinfo;
 
-    // typedef multi_index<name("tokeninfo"), tokeninfo> tokeninfo;
+    // inclusive span of serials, used to move many tokens without listing each serial
+    struct serial_range {
+        uint64_t first_serial;
+        uint64_t last_serial;
+
+        EOSLIB_SERIALIZE(serial_range, (first_serial)(last_serial))
+    };
+
+    typedef multi_index<name("tokenstats"), tokenstats> tokenstats_table;
+
+    typedef multi_index<name("tokenranges"), tokenrange,
+        indexed_by<name("byowner"), const_mem_fun<tokenrange, uint64_t, &tokenrange::get_owner>>,
+        indexed_by<name("byserial"), const_mem_fun<tokenrange, uint128_t, &tokenrange::by_serial>>
+    > tokenranges_table;
 
-    // typedef multi_index<name("tokenstats"), tokenstats> tokenstats;
+    typedef multi_index<name("metaoverride"), metaoverride,
+        indexed_by<name("byserial"), const_mem_fun<metaoverride, uint128_t, &metaoverride::by_serial>>
+    > metaoverrides_table;
 
-    typedef singleton<name("symbolinfo"), symbolinfo> symbolinfo;
-	symbolinfo _symbolinfo;
+    typedef singleton<name("symbolinfo"), symbolinfo> symbolinfo_singleton;
+	symbolinfo_singleton _symbolinfo;
 
     // CREATE: The create method instantiates a token. This is required before any tokens can be 
     // issued and sets properties such as the category, name, maximum supply, who has the ability 
@@ -74,22 +123,29 @@ public:
         bool transferable, int64_t max_supply);
 
     // ISSUE: The issue method mints a token and gives ownership to the ‘to’ account name. For a 
-    // valid call the symbol, category, and token name must have been first created. Quantity must 
-    // be equal to 1 if non-fungible or semi-fungible, otherwise quantity must be greater or equal 
-    // to 0.0001.
+    // valid call the symbol, category, and token name must have been first created. If non-fungible 
+    // or semi-fungible, quantity is the whole number of serials minted as a single range, otherwise 
+    // quantity must be greater or equal to 0.0001. Tokens use the class metadata template unless 
+    // metadata_uri is set, which overrides it for a single issued token.
 
     ACTION issue(name to, name category, name token_name, double quantity, string metadata_uri, 
         string memo);
 
+    // SETMETAURI: Sets the metadata uri template shared by every token of a class. Each {serial} in 
+    // the template is replaced by the token's serial number. Only the issuer may call this function. 
+    // The template may be at most 256 bytes, since token stats are paid by the contract.
+
+    ACTION setmetauri(name category, name token_name, string metadata_template);
+
     // PAUSEXFER: Pauses all transfers of all tokens. Only callable by the contract. If pause is true, 
     // will pause. If pause is false will unpause transfers.
 
     ACTION pausexfer(bool pause);
 
     // BURNNFT: Burn method destroys specified tokens and frees the RAM. Only owner may call burn 
-    // function and burnable must be true.
+    // function and burnable must be true. Serials are given as sorted, non-overlapping spans.
 
-    ACTION burnnft(name owner, vector<uint64_t> tokeninfo_ids);
+    ACTION burnnft(name owner, name category, name token_name, vector<serial_range> serials);
 
     // BURN: Burn method destroys fungible tokens and frees the RAM if all are deleted. Only owner may 
     // call Burn function and burnable must be true.
@@ -97,16 +153,27 @@ public:
     ACTION burn(name owner, uint64_t global_id, double quantity);
 
     // TRANSFERNFT: Used to transfer non-fungible tokens. This allows for the ability to batch send tokens 
-    // in one function call by passing in a list of token ids. Only the token owner can successfully call 
-    // this function and transferable must be true.
+    // in one function call by passing in sorted, non-overlapping spans of serial numbers. Only the token 
+    // owner can successfully call this function and transferable must be true. Received spans are merged 
+    // with the recipient's adjacent ranges.
 
-    ACTION transfernft(name from, name to, vector<uint64_t> tokeninfo_ids, string memo);
+    ACTION transfernft(name from, name to, name category, name token_name, 
+        vector<serial_range> serials, string memo);
 
     // TRANSFER: The standard transfer method is callable only on fungible tokens. Instead of specifying 
     // tokens individually, a token is specified by it’s global id followed by an amount desired to be sent.
 
     ACTION transfer(name from, name to, uint64_t global_id, double quantity, string memo);
 
+    //========== functions ==========
+
+    //moves serials [first_serial, last_serial] from one owner to another, splitting ranges as needed
+    //and merging with adjacent ranges of the new owner, burns the serials if to is empty
+    void move_serials(name from, name to, uint64_t global_id, uint64_t first_serial, uint64_t last_serial);
+
+    //validates and moves each span, returns serials moved
+    uint64_t move_serial_spans(name from, name to, uint64_t global_id, const vector<serial_range>& serials);
+
 };
 
 // scope is self
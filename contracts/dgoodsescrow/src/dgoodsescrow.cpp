@@ -14,3 +14,261 @@ dgoodsescrow::dgoodsescrow(name self, name code, datastream<const char*> ds) :
 
 dgoodsescrow::~dgoodsescrow() {}
 
+//========== actions ==========
+
+void dgoodsescrow::create(name issuer, name category, name token_name, bool fungible, bool burnable,
+    bool transferable, int64_t max_supply) {
+    //authenticate
+    require_auth(get_self());
+
+    //get token stats
+    tokenstats_table stats(get_self(), category.value);
+    auto st = stats.find(token_name.value);
+
+    //validate
+    check(is_account(issuer), "issuer account does not exist");
+    check(st == stats.end(), "token name already exists in category");
+    check(max_supply > 0, "max supply must be positive");
+
+    //assign next global id
+    auto info = _symbolinfo.get_or_default(symbolinfo{contract_symbol, 0});
+    uint64_t global_id = info.global_id;
+    info.global_id += 1;
+    _symbolinfo.set(info, get_self());
+
+    //emplace token stats, ram paid by contract
+    stats.emplace(get_self(), [&](auto& row) {
+        row.fungible = fungible;
+        row.burnable = burnable;
+        row.transferable = transferable;
+        row.issuer = issuer;
+        row.token_name = token_name;
+        row.global_id = global_id;
+        row.max_supply = uint64_t(max_supply);
+        row.current_supply = 0;
+        row.next_serial = 1;
+        row.metadata_template = "";
+    });
+}
+
+void dgoodsescrow::issue(name to, name category, name token_name, double quantity, string metadata_uri, 
+    string memo) {
+    //get token stats
+    tokenstats_table stats(get_self(), category.value);
+    auto& st = stats.get(token_name.value, "token not found");
+
+    //authenticate
+    require_auth(st.issuer);
+
+    //validate
+    check(is_account(to), "to account does not exist");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+    check(metadata_uri.size() <= 256, "metadata uri has more than 256 bytes");
+    check(!st.fungible, "fungible issuance is in development");
+
+    //validate range before converting, out of range doubles can't be cast to integers
+    check(quantity >= 1 && quantity <= double(st.max_supply), "quantity must be between 1 and max supply");
+
+    uint64_t count = uint64_t(quantity);
+    check(double(count) == quantity, "quantity must be a whole number of serials");
+    check(count <= st.max_supply - (st.next_serial - 1), "quantity exceeds max supply");
+    check(metadata_uri == "" || count == 1, "metadata uri override can only be set on a single token");
+
+    //emplace a single range for every serial issued, ram paid by issuer
+    tokenranges_table ranges(get_self(), get_self().value);
+    ranges.emplace(st.issuer, [&](auto& row) {
+        row.id = ranges.available_primary_key();
+        row.global_id = st.global_id;
+        row.owner = to;
+        row.first_serial = st.next_serial;
+        row.last_serial = st.next_serial + count - 1;
+    });
+
+    //emplace metadata override, ram paid by issuer
+    if (metadata_uri != "") {
+        metaoverrides_table overrides(get_self(), get_self().value);
+        overrides.emplace(st.issuer, [&](auto& row) {
+            row.id = overrides.available_primary_key();
+            row.global_id = st.global_id;
+            row.serial_number = st.next_serial;
+            row.metadata_uri = metadata_uri;
+        });
+    }
+
+    //update supply
+    stats.modify(st, same_payer, [&](auto& row) {
+        row.current_supply += quantity;
+        row.next_serial += count;
+    });
+
+    require_recipient(to);
+}
+
+void dgoodsescrow::setmetauri(name category, name token_name, string metadata_template) {
+    //get token stats
+    tokenstats_table stats(get_self(), category.value);
+    auto& st = stats.get(token_name.value, "token not found");
+
+    //authenticate
+    require_auth(st.issuer);
+
+    //validate
+    check(!st.fungible, "fungible tokens have no metadata uri");
+    check(metadata_template.size() <= 256, "metadata template has more than 256 bytes"); //row is paid by contract
+
+    //update template
+    stats.modify(st, same_payer, [&](auto& row) {
+        row.metadata_template = metadata_template;
+    });
+}
+
+void dgoodsescrow::burnnft(name owner, name category, name token_name, vector<serial_range> serials) {
+    //authenticate
+    require_auth(owner);
+
+    //get token stats
+    tokenstats_table stats(get_self(), category.value);
+    auto& st = stats.get(token_name.value, "token not found");
+
+    //validate
+    check(st.burnable, "token is not burnable");
+
+    //erase serials
+    uint64_t burned = move_serial_spans(owner, name(0), st.global_id, serials);
+
+    //update supply
+    stats.modify(st, same_payer, [&](auto& row) {
+        row.current_supply -= double(burned);
+    });
+}
+
+void dgoodsescrow::transfernft(name from, name to, name category, name token_name, 
+    vector<serial_range> serials, string memo) {
+    //authenticate
+    require_auth(from);
+
+    //get token stats
+    tokenstats_table stats(get_self(), category.value);
+    auto& st = stats.get(token_name.value, "token not found");
+
+    //validate
+    check(from != to, "cannot transfer to self");
+    check(is_account(to), "to account does not exist");
+    check(memo.size() <= 256, "memo has more than 256 bytes");
+    check(st.transferable, "token is not transferable");
+
+    //move serials
+    move_serial_spans(from, to, st.global_id, serials);
+
+    require_recipient(from);
+    require_recipient(to);
+}
+
+//========== functions ==========
+
+void dgoodsescrow::move_serials(name from, name to, uint64_t global_id, uint64_t first_serial, uint64_t last_serial) {
+    //get token ranges
+    tokenranges_table ranges(get_self(), get_self().value);
+    auto by_serial = ranges.get_index<name("byserial")>();
+
+    while (true) {
+        //find range containing first serial, ranges are keyed by their last serial
+        auto itr = by_serial.lower_bound((uint128_t(global_id) << 64) | first_serial);
+
+        //validate
+        check(itr != by_serial.end() && itr->global_id == global_id && itr->first_serial <= first_serial, 
+            "serial not found");
+        check(itr->owner == from, "serial not owned by account");
+
+        auto& rng = ranges.get(itr->id);
+        uint64_t rng_first = rng.first_serial;
+        uint64_t rng_last = rng.last_serial;
+        uint64_t span_last = rng_last < last_serial ? rng_last : last_serial;
+
+        //split off serials before the span, ram paid by owner
+        if (rng_first < first_serial) {
+            ranges.emplace(from, [&](auto& row) {
+                row.id = ranges.available_primary_key();
+                row.global_id = global_id;
+                row.owner = from;
+                row.first_serial = rng_first;
+                row.last_serial = first_serial - 1;
+            });
+        }
+
+        //split off serials after the span, ram paid by owner
+        if (span_last < rng_last) {
+            ranges.emplace(from, [&](auto& row) {
+                row.id = ranges.available_primary_key();
+                row.global_id = global_id;
+                row.owner = from;
+                row.first_serial = span_last + 1;
+                row.last_serial = rng_last;
+            });
+        }
+
+        //burn or reassign the span
+        if (to == name(0)) {
+            ranges.erase(rng);
+
+            //erase metadata overrides of burned serials
+            metaoverrides_table overrides(get_self(), get_self().value);
+            auto by_override_serial = overrides.get_index<name("byserial")>();
+            auto ovr = by_override_serial.lower_bound((uint128_t(global_id) << 64) | first_serial);
+
+            while (ovr != by_override_serial.end() && ovr->global_id == global_id && ovr->serial_number <= span_last) {
+                ovr = by_override_serial.erase(ovr);
+            }
+        } else {
+            uint64_t merged_first = first_serial;
+            uint64_t merged_last = span_last;
+
+            //merge with range of new owner ending just before the span
+            if (first_serial > 0) {
+                auto left = by_serial.find((uint128_t(global_id) << 64) | (first_serial - 1));
+                if (left != by_serial.end() && left->owner == to) {
+                    merged_first = left->first_serial;
+                    by_serial.erase(left);
+                }
+            }
+
+            //merge with range of new owner starting just after the span
+            auto right = by_serial.lower_bound((uint128_t(global_id) << 64) | (span_last + 1));
+            if (right != by_serial.end() && right->global_id == global_id && 
+                right->first_serial == span_last + 1 && right->owner == to) {
+                merged_last = right->last_serial;
+                by_serial.erase(right);
+            }
+
+            ranges.modify(rng, same_payer, [&](auto& row) {
+                row.owner = to;
+                row.first_serial = merged_first;
+                row.last_serial = merged_last;
+            });
+        }
+
+        if (span_last == last_serial) {
+            break;
+        }
+
+        first_serial = span_last + 1;
+    }
+}
+
+uint64_t dgoodsescrow::move_serial_spans(name from, name to, uint64_t global_id, const vector<serial_range>& serials) {
+    //validate
+    check(serials.size() > 0, "must specify at least one serial range");
+
+    uint64_t moved = 0;
+
+    for (size_t i = 0; i < serials.size(); i++) {
+        check(serials[i].first_serial <= serials[i].last_serial, "invalid serial range");
+        check(i == 0 || serials[i - 1].last_serial < serials[i].first_serial, 
+            "serial ranges must be sorted and not overlap");
+
+        move_serials(from, to, global_id, serials[i].first_serial, serials[i].last_serial);
+        moved += serials[i].last_serial - serials[i].first_serial + 1;
+    }
+
+    return moved;
+}
@@ -13,6 +13,9 @@
 #include <eosiolib/action.hpp>
 #include <eosiolib/transaction.hpp>
 #include <eosiolib/ignore.hpp>
+#include <eosiolib/singleton.hpp>
+#include <eosiolib/crypto.hpp>
+#include <eosiolib/binary_extension.hpp>
 
 using namespace std;
 using namespace eosio;
@@ -36,6 +39,12 @@ public:
     const asset PROJECT_FEE = asset(250000, CORE_SYM); //25 TLOS
     const asset RAM_FEE = asset(1000, CORE_SYM); //0.1 TLOS
     const uint32_t DAY_IN_SECS = 86400;
+    const uint8_t EVENT_VERSION = 1;
+    const uint16_t DEFAULT_BUCKET_CAPACITY = 10;
+    const uint32_t DEFAULT_REFILL_SECS = 30;
+    const uint8_t MERKLE_DEPTH = 32;
+    const uint8_t MAX_TAGS = 5;
+    const uint32_t ARCHIVE_DELAY = 2592000; //30 days
 
     enum PROJECT_STATUS : uint8_t {
         SETUP, //0
@@ -47,6 +56,16 @@ public:
 
     //======================== tables ========================
 
+    /**
+     * Fields added after the original projects, accounts and donations layouts are
+     * appended as binary extensions. Older rows decode with the extensions absent and
+     * readers fall back to defaults. A row only grows when an action emplaces its
+     * extensions, which must happen while the row's ram payer has signed or after
+     * billing the row to the contract, and always in order through upgrade().
+     * needs_upgrade() checks the last extension, so it stays correct as fields are
+     * appended. Changing or removing a field still needs a migration.
+     */
+
     //@scope get_self().value
     //@ram 
     TABLE project {
@@ -70,13 +89,24 @@ public:
         uint32_t end_time;
         uint8_t status;
 
+        binary_extension<vector<name>> tags;
+
         uint64_t primary_key() const { return project_name.value; }
         uint64_t by_cat() const { return category.value; }
         uint64_t by_end_time() const { return static_cast<uint64_t>(end_time); }
         //TODO: make by_creator() index?
+
+        //true if the row is missing any extension, checked on the last one
+        bool needs_upgrade() const { return !tags.has_value(); }
+
+        //emplaces defaults for missing extensions
+        void upgrade() {
+            if (!tags.has_value()) tags.emplace(vector<name>());
+        }
+
         EOSLIB_SERIALIZE(project, (project_name)(category)(creator)
             (title)(description)(link)(requested)(received)(donations)(preorders)
-            (begin_time)(end_time)(status))
+            (begin_time)(end_time)(status)(tags))
     };
 
     typedef multi_index<name("projects"), project,
@@ -91,12 +121,42 @@ public:
         asset balance;
         asset rewards;
 
+        //rate limiting, refilled lazily from last_refill
+        binary_extension<uint16_t> bucket;
+        binary_extension<uint32_t> last_refill;
+        binary_extension<bool> suspended;
+
         uint64_t primary_key() const { return account_name.value; }
-        EOSLIB_SERIALIZE(account, (account_name)(balance)(rewards))
+
+        //true if the row is missing any extension, checked on the last one
+        bool needs_upgrade() const { return !suspended.has_value(); }
+
+        //emplaces defaults for missing extensions, earlier extensions first
+        void upgrade() {
+            if (!bucket.has_value()) bucket.emplace(0);
+            if (!last_refill.has_value()) last_refill.emplace(0);
+            if (!suspended.has_value()) suspended.emplace(false);
+        }
+
+        EOSLIB_SERIALIZE(account, (account_name)(balance)(rewards)
+            (bucket)(last_refill)(suspended))
     };
 
     typedef multi_index<name("accounts"), account> accounts_table;
 
+    //@scope get_self().value
+    //@ram
+    TABLE pledgekey {
+        name account_name;
+        public_key pledge_key;
+        uint64_t pledge_nonce; //last settled pledge nonce
+
+        uint64_t primary_key() const { return account_name.value; }
+        EOSLIB_SERIALIZE(pledgekey, (account_name)(pledge_key)(pledge_nonce))
+    };
+
+    typedef multi_index<name("pledgekeys"), pledgekey> pledgekeys_table;
+
     //@scope get_self().value
     //@ram 
     TABLE donation {
@@ -116,6 +176,94 @@ public:
         indexed_by<name("byproject"), const_mem_fun<donation, uint64_t, &donation::by_project>>
     > donations_table;
 
+    //@scope get_self().value
+    //@ram
+    TABLE archived {
+        name project_name;
+        name creator;
+        asset received;
+        uint8_t status;
+        checksum256 content_hash; //sha256 of the packed project row
+
+        uint64_t primary_key() const { return project_name.value; }
+        EOSLIB_SERIALIZE(archived, (project_name)(creator)(received)(status)(content_hash))
+    };
+
+    typedef multi_index<name("archived"), archived> archived_table;
+
+    //@scope get_self().value
+    //@ram
+    TABLE tag {
+        uint64_t tag_id;
+        name tag_name;
+        name project_name;
+
+        uint64_t primary_key() const { return tag_id; }
+        uint128_t by_tag_proj() const { return (uint128_t(tag_name.value) << 64) | project_name.value; }
+        EOSLIB_SERIALIZE(tag, (tag_id)(tag_name)(project_name))
+    };
+
+    typedef multi_index<name("tags"), tag,
+        indexed_by<name("bytagproj"), const_mem_fun<tag, uint128_t, &tag::by_tag_proj>>
+    > tags_table;
+
+    //@scope get_self().value
+    //@ram
+    TABLE recurpledge {
+        uint64_t pledge_id;
+        name donor;
+        name project_name;
+
+        asset rate; //donated every period
+        uint32_t period;
+        uint32_t start_time;
+        asset cap;
+        asset settled;
+        uint32_t last_settled; //end of the last settled period
+
+        uint64_t primary_key() const { return pledge_id; }
+        uint64_t by_donor() const { return donor.value; }
+        uint64_t by_next_due() const { return static_cast<uint64_t>(last_settled) + period; }
+        EOSLIB_SERIALIZE(recurpledge, (pledge_id)(donor)(project_name)
+            (rate)(period)(start_time)(cap)(settled)(last_settled))
+    };
+
+    typedef multi_index<name("recurring"), recurpledge,
+        indexed_by<name("bydonor"), const_mem_fun<recurpledge, uint64_t, &recurpledge::by_donor>>,
+        indexed_by<name("bynextdue"), const_mem_fun<recurpledge, uint64_t, &recurpledge::by_next_due>>
+    > recurring_table;
+
+    //@scope get_self().value
+    //@ram
+    TABLE donationroot {
+        name project_name;
+        uint32_t leaf_count;
+        asset total;
+        uint8_t status; //final project status
+
+        vector<checksum256> branch; //incremental merkle frontier, cleared once sealed
+        checksum256 root;
+        bool sealed;
+
+        uint64_t primary_key() const { return project_name.value; }
+        EOSLIB_SERIALIZE(donationroot, (project_name)(leaf_count)(total)(status)
+            (branch)(root)(sealed))
+    };
+
+    typedef multi_index<name("donroots"), donationroot> donationroots_table;
+
+    //@scope project_name.value
+    //@ram 
+    TABLE claim {
+        uint32_t leaf_index;
+        name donor;
+
+        uint64_t primary_key() const { return leaf_index; }
+        EOSLIB_SERIALIZE(claim, (leaf_index)(donor))
+    };
+
+    typedef multi_index<name("claims"), claim> claims_table;
+
     //@scope get_self().value
     //@ram
     TABLE category {
@@ -142,16 +290,79 @@ public:
 
     typedef multi_index<name("featured"), featured> featured_table;
 
+    //@scope get_self().value
+    //@ram
+    TABLE config {
+        uint16_t bucket_capacity; //0 disables rate limiting
+        uint32_t refill_secs; //seconds to refill one token
+
+        EOSLIB_SERIALIZE(config, (bucket_capacity)(refill_secs))
+    };
+
+    typedef singleton<name("config"), config> config_singleton;
+
+    //@scope get_self().value
+    //@ram
+    TABLE archcursor {
+        uint32_t end_time; //last project scanned by archive, byendtime order
+        name project_name;
+
+        EOSLIB_SERIALIZE(archcursor, (end_time)(project_name))
+    };
+
+    typedef singleton<name("archcursor"), archcursor> archcursor_singleton;
+
+    //@scope get_self().value
+    //@ram
+    TABLE chaininfo {
+        checksum256 chain_id; //signed into every pledge so pledges can't be replayed on another chain
+
+        EOSLIB_SERIALIZE(chaininfo, (chain_id))
+    };
+
+    typedef singleton<name("chaininfo"), chaininfo> chaininfo_singleton;
+
+    //======================== pledges ========================
+
+    //donation signed off-chain by the donor's pledge key, settled by a relayer
+    struct pledge {
+        name donor;
+        name project_name;
+        asset amount;
+        uint64_t nonce;
+        uint32_t expiry;
+        signature sig; //signs sha256 of packed (chain_id, contract, donor, project_name, amount, nonce, expiry)
+
+        EOSLIB_SERIALIZE(pledge, (donor)(project_name)(amount)(nonce)(expiry)(sig))
+    };
+
+    //======================== events ========================
+
+    //fixed layout event emitted through the log action
+    //status is only meaningful when project_name is set
+    struct event {
+        uint8_t version;
+        name event_type;
+        name project_name;
+        name account_name;
+        int64_t received_delta;
+        int64_t balance_delta;
+        uint8_t status;
+
+        EOSLIB_SERIALIZE(event, (version)(event_type)(project_name)(account_name)
+            (received_delta)(balance_delta)(status))
+    };
+
     //======================== project actions ========================
 
     //create a new project
     ACTION newproject(name project_name, name category, name creator, 
-        string title, string description, asset requested);
+        string title, string description, asset requested, vector<name> tags);
 
     //TODO: make optional params
     //update the content of the project
     ACTION updateproj(name project_name, name creator,
-        string new_title, string new_desc, string new_link, asset new_requested);
+        string new_title, string new_desc, string new_link, asset new_requested, vector<name> new_tags);
 
     //opens the project up for funding for the specified number of days
     ACTION openfunding(name project_name, name creator, uint8_t length_in_days);
@@ -175,6 +386,24 @@ public:
     //reclaims an entire donation from a project
     ACTION undonate(name project_name, name donor, string memo);
 
+    //registers the key used to sign off-chain pledges
+    ACTION setpledgekey(name account_name, public_key pledge_key);
+
+    //settles a batch of signed pledges, new donation ram paid by relayer
+    ACTION settlepledges(name relayer, vector<pledge> pledges);
+
+    //pledges a fixed donation every period until the cap or the end of funding
+    ACTION newrecur(name donor, name project_name, asset rate, uint32_t period, asset cap);
+
+    //settles what is owed on a recurring pledge, then removes it
+    ACTION cancelrecur(name donor, uint64_t pledge_id);
+
+    //settles what is owed on a recurring pledge, callable by the donor or project creator
+    ACTION settlerecur(name actor, uint64_t pledge_id);
+
+    //settles up to max_rows recurring pledges that are due, callable by anyone
+    ACTION settle(uint16_t max_rows);
+
     //withdraws unspent grassroots balance back to eosio.token account
     ACTION withdraw(name account_name, asset amount);
 
@@ -185,6 +414,13 @@ public:
     //redeems ROOTS for various rewards packages
     ACTION redeemroots(name account_name, name package_name, name project_name);
 
+    //folds up to max_rows donations of a finished project into its merkle root, erasing them
+    ACTION compactdons(name project_name, uint16_t max_rows);
+
+    //proves a compacted donation against the project's merkle root
+    ACTION claimproof(name project_name, name donor, uint64_t donation_id, asset total,
+        uint32_t leaf_index, vector<checksum256> proof);
+
     //======================== order actions ========================
 
     
@@ -206,11 +442,50 @@ public:
     //emplaces or extends a featured project
     ACTION editfeatured(name project_name, uint32_t added_seconds);
 
+    //moves up to max_rows finished projects with compacted donations into the archived table,
+    //resuming after the last project scanned by the previous call
+    ACTION archive(uint16_t max_rows);
+
+    //sets the per-account rate limit for mutating actions
+    ACTION setratelimit(uint16_t bucket_capacity, uint32_t refill_secs);
+
+    //sets the id of the chain the contract is deployed on, required before settling pledges
+    ACTION setchainid(checksum256 chain_id);
+
+    //========== event actions ==========
+
+    //no-op action carrying an event for off-chain consumers
+    ACTION log(event evt);
+
     //========== functions ==========
 
     //returns true if parameter name is a valid category
     bool is_valid_category(name category);
 
+    //replaces a project's entries in the tags table, ram paid by payer
+    void set_project_tags(name project_name, name payer, const vector<name>& old_tags, const vector<name>& new_tags);
+
+    //adds to a donor's donation and the project's received amount, returns the new project status
+    uint8_t add_donation(name donor, name project_name, asset amount, name payer);
+
+    //settles whole periods owed on a recurring pledge, skipping periods the donor's balance can't cover
+    //erases the pledge when finished and returns whether it was erased
+    bool settle_recurring(recurring_table& recurring, const recurpledge& rec, name payer);
+
+    //refills the account's bucket and spends one token, fails if empty or suspended
+    //upgrade_payer pays to grow a legacy row, same_payer when the row's payer has signed
+    void consume_rate_token(accounts_table& accounts, const account& acc, name upgrade_payer);
+
+    //returns the merkle leaf for a donation
+    checksum256 donation_leaf(uint64_t donation_id, name donor, name project_name, asset total);
+
+    //returns the merkle parent of two nodes
+    checksum256 hash_pair(const checksum256& left, const checksum256& right);
+
+    //sends an inline log action describing a state change
+    void emit_event(name event_type, name project_name, name account_name,
+        int64_t received_delta, int64_t balance_delta, uint8_t status);
+
     //========== reactions ==========
 
     //catches transfers sent to @gograssroots
@@ -7,6 +7,8 @@
  */
 
 #include "../include/grassroots.hpp"
+#include <algorithm>
+#include <map>
 
 grassroots::grassroots(name self, name code, datastream<const char*> ds) : contract(self, code, ds) {}
 
@@ -15,7 +17,7 @@ grassroots::~grassroots() {}
 //======================== project actions ========================
 
 void grassroots::newproject(name project_name, name category, name creator, 
-    string title, string description, asset requested) {
+    string title, string description, asset requested, vector<name> tags) {
     //authenticate
     require_auth(creator);
 
@@ -23,12 +25,19 @@ void grassroots::newproject(name project_name, name category, name creator,
     accounts_table accounts(get_self(), get_self().value);
     auto& acc = accounts.get(creator.value, "account not registered");
 
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
     //get projects
     projects_table projects(get_self(), get_self().value);
     auto proj = projects.find(project_name.value);
 
+    //get archived projects
+    archived_table archives(get_self(), get_self().value);
+    auto arch = archives.find(project_name.value);
+
     //validate
-    check(proj == projects.end(), "project name already taken");
+    check(proj == projects.end() && arch == archives.end(), "project name already taken");
     check(is_valid_category(category), "invalid category");
     check(title != "", "title cannot be blank");
     check(description != "", "description cannot be blank");
@@ -50,11 +59,17 @@ void grassroots::newproject(name project_name, name category, name creator,
         row.begin_time = 0;
         row.end_time = 0;
         row.status = SETUP;
+        row.tags.emplace(tags);
     });
+
+    //index tags, ram paid by creator
+    set_project_tags(project_name, creator, vector<name>(), tags);
+
+    emit_event(name("newproject"), project_name, creator, 0, 0, SETUP);
 }
 
 void grassroots::updateproj(name project_name, name creator,
-        string new_title, string new_desc, string new_link, asset new_requested) {
+        string new_title, string new_desc, string new_link, asset new_requested, vector<name> new_tags) {
     //get project
     projects_table projects(get_self(), get_self().value);
     auto& proj = projects.get(project_name.value, "project not found");
@@ -70,13 +85,20 @@ void grassroots::updateproj(name project_name, name creator,
     check(new_requested >= asset(0, CORE_SYM), "must request a positive amount");
     // check(proj.project_status == SETUP, "cannot update project after funding has opened");
 
-    //update project info
+    //reindex tags, ram paid by creator
+    set_project_tags(project_name, creator, proj.tags.value_or(), new_tags);
+
+    //update project info, ram growth from upgrading is paid by creator
     projects.modify(proj, same_payer, [&](auto& row) {
+        row.upgrade();
         row.title = new_title;
         row.description = new_desc;
         row.link = new_link;
         row.requested = new_requested;
+        row.tags.emplace(new_tags);
     });
+
+    emit_event(name("updateproj"), project_name, creator, 0, 0, proj.status);
 }
 
 void grassroots::openfunding(name project_name, name creator, uint8_t length_in_days) {
@@ -92,6 +114,9 @@ void grassroots::openfunding(name project_name, name creator, uint8_t length_in_
     require_auth(creator);
     check(creator == proj.creator, "only project creator can open project for funding");
 
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
     //validate
     check(length_in_days >= 1 && length_in_days <= 180, "project length must be between 1 and 180 days");
     check(acc.balance >= PROJECT_FEE, "insufficient balance to cover project fee");
@@ -107,6 +132,8 @@ void grassroots::openfunding(name project_name, name creator, uint8_t length_in_
         row.end_time = now() + uint32_t(length_in_days * 86400);
         row.status = FUNDING;
     });
+
+    emit_event(name("openfunding"), project_name, creator, 0, -PROJECT_FEE.amount, FUNDING);
 }
 
 void grassroots::cancelproj(name project_name, name creator) {
@@ -126,6 +153,8 @@ void grassroots::cancelproj(name project_name, name creator) {
     projects.modify(proj, same_payer, [&](auto& row) {
         row.status = CANCELLED;
     });
+
+    emit_event(name("cancelproj"), project_name, creator, 0, 0, CANCELLED);
 }
 
 void grassroots::deleteproj(name project_name, name creator) {
@@ -140,8 +169,13 @@ void grassroots::deleteproj(name project_name, name creator) {
     //validate
     check(proj.status == SETUP, "can only delete projects in SETUP");
 
+    //remove tags
+    set_project_tags(project_name, creator, proj.tags.value_or(), vector<name>());
+
     //delete project
     projects.erase(proj);
+
+    emit_event(name("deleteproj"), project_name, creator, 0, 0, SETUP);
 }
 
 //======================== account actions ========================
@@ -162,7 +196,10 @@ void grassroots::registeracct(name account_name) {
         row.account_name = account_name;
         row.balance = asset(0, CORE_SYM);
         row.rewards = asset(0, ROOTS_SYM);
+        row.upgrade();
     });
+
+    emit_event(name("registeracct"), name(0), account_name, 0, 0, 0);
 }
 
 void grassroots::donate(name project_name, name donor, asset amount, string memo) {
@@ -174,15 +211,22 @@ void grassroots::donate(name project_name, name donor, asset amount, string memo
     accounts_table accounts(get_self(), get_self().value);
     auto& acc = accounts.get(donor.value, "account not registered");
 
-    //find donation
+    //find donor's donation to project
     donations_table donations(get_self(), get_self().value);
     auto by_donor = donations.get_index<name("bydonor")>();
-    auto don = by_donor.find(project_name.value);
+    auto don = by_donor.lower_bound(donor.value);
+
+    while (don != by_donor.end() && don->donor == donor && don->project_name != project_name) {
+        don++;
+    }
 
     //authenticate
     require_auth(donor);
     check(acc.account_name == donor, "cannot donate from someone else's account");
 
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
     //validate
     check(proj.end_time > now(), "project funding is over");
     check(amount > asset(0, CORE_SYM), "must donate a positive amount");
@@ -192,7 +236,7 @@ void grassroots::donate(name project_name, name donor, asset amount, string memo
     uint32_t new_donors = 0;
 
     //update donations
-    if (don == by_donor.end()) { //donation not found for project
+    if (don == by_donor.end() || don->donor != donor) { //donation not found for project
         //increment project donors
         new_donors = 1;
 
@@ -226,6 +270,8 @@ void grassroots::donate(name project_name, name donor, asset amount, string memo
         row.donations += new_donors;
         row.status = new_status;
     });
+
+    emit_event(name("donate"), project_name, donor, amount.amount, -amount.amount, new_status);
 }
 
 void grassroots::undonate(name project_name, name donor, string memo) {
@@ -237,18 +283,31 @@ void grassroots::undonate(name project_name, name donor, string memo) {
     accounts_table accounts(get_self(), get_self().value);
     auto& acc = accounts.get(donor.value, "account not registered");
 
-    //find donation
+    //find donor's donation to project
     donations_table donations(get_self(), get_self().value);
     auto by_donor = donations.get_index<name("bydonor")>();
-    auto& don = by_donor.get(project_name.value, "donation not found");
+    auto itr = by_donor.lower_bound(donor.value);
+
+    while (itr != by_donor.end() && itr->donor == donor && itr->project_name != project_name) {
+        itr++;
+    }
+
+    check(itr != by_donor.end() && itr->donor == donor, "donation not found");
+    auto& don = donations.get(itr->donation_id);
 
     //authenticate
     require_auth(donor);
     check(acc.account_name == donor, "cannot undonate another account's donation");
 
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
     //validate
     check(proj.status == FUNDING, "project has already been funded");
 
+    //save total for event, can't read don after erase
+    auto total = don.total;
+
     //remove donation from project
     projects.modify(proj, same_payer, [&](auto& row) {
         row.received -= don.total;
@@ -262,6 +321,252 @@ void grassroots::undonate(name project_name, name donor, string memo) {
 
     //delete donation record
     donations.erase(don);
+
+    emit_event(name("undonate"), project_name, donor, -total.amount, total.amount, proj.status);
+}
+
+void grassroots::setpledgekey(name account_name, public_key pledge_key) {
+    //authenticate
+    require_auth(account_name);
+
+    //validate
+    accounts_table accounts(get_self(), get_self().value);
+    accounts.get(account_name.value, "account not registered");
+
+    //emplace or replace key, ram paid by account
+    pledgekeys_table keys(get_self(), get_self().value);
+    auto key = keys.find(account_name.value);
+
+    if (key == keys.end()) {
+        keys.emplace(account_name, [&](auto& row) {
+            row.account_name = account_name;
+            row.pledge_key = pledge_key;
+            row.pledge_nonce = 0;
+        });
+    } else {
+        keys.modify(key, same_payer, [&](auto& row) {
+            row.pledge_key = pledge_key;
+        });
+    }
+
+    emit_event(name("setpledgekey"), name(0), account_name, 0, 0, 0);
+}
+
+void grassroots::settlepledges(name relayer, vector<pledge> pledges) {
+    //authenticate
+    require_auth(relayer);
+
+    //validate
+    check(pledges.size() > 0, "must settle at least one pledge");
+
+    //get tables
+    projects_table projects(get_self(), get_self().value);
+    accounts_table accounts(get_self(), get_self().value);
+    donations_table donations(get_self(), get_self().value);
+    auto by_donor = donations.get_index<name("bydonor")>();
+    pledgekeys_table keys(get_self(), get_self().value);
+    chaininfo_singleton chain(get_self(), get_self().value);
+    check(chain.exists(), "chain id not set");
+    checksum256 chain_id = chain.get().chain_id;
+
+    //totals coalesced across the batch, written once each
+    map<uint64_t, asset> debits; //donor -> amount
+    map<uint64_t, uint64_t> nonces; //donor -> last nonce
+    map<uint64_t, asset> credits; //project -> amount
+    map<uint64_t, uint32_t> new_donors; //project -> new donations
+    map<pair<uint64_t, uint64_t>, asset> totals; //(donor, project) -> amount
+
+    auto add = [](auto& totals_map, auto key, asset amount) {
+        auto itr = totals_map.find(key);
+        if (itr == totals_map.end()) {
+            totals_map[key] = amount;
+        } else {
+            itr->second += amount;
+        }
+    };
+
+    for (const auto& p : pledges) {
+        auto& acc = accounts.get(p.donor.value, "donor not registered");
+        auto& proj = projects.get(p.project_name.value, "project not found");
+        auto& key = keys.get(p.donor.value, "donor has no pledge key registered");
+
+        //validate
+        check(!acc.suspended.value_or(), "account is suspended");
+        check(p.expiry >= now(), "pledge has expired");
+        check(proj.end_time > now(), "project funding is over");
+        check(p.amount.symbol == CORE_SYM, "can only pledge native currency");
+        check(p.amount > asset(0, CORE_SYM), "must pledge a positive amount");
+
+        //nonces must increase per donor, including within the batch
+        auto last = nonces.find(p.donor.value);
+        uint64_t last_nonce = last == nonces.end() ? key.pledge_nonce : last->second;
+        check(p.nonce > last_nonce, "pledge nonce already used");
+        nonces[p.donor.value] = p.nonce;
+
+        //verify donor signature
+        auto data = pack(make_tuple(chain_id, get_self(), p.donor, p.project_name, p.amount, p.nonce, p.expiry));
+        checksum256 digest = sha256(data.data(), data.size());
+        assert_recover_key(digest, p.sig, key.pledge_key);
+
+        add(debits, p.donor.value, p.amount);
+        add(credits, p.project_name.value, p.amount);
+        add(totals, make_pair(p.donor.value, p.project_name.value), p.amount);
+    }
+
+    //subtract pledges from donor balances, record last nonce
+    for (const auto& d : debits) {
+        auto& acc = accounts.get(d.first);
+        check(acc.balance >= d.second, "insufficient balance");
+
+        accounts.modify(acc, same_payer, [&](auto& row) {
+            row.balance -= d.second;
+        });
+
+        keys.modify(keys.get(d.first), same_payer, [&](auto& row) {
+            row.pledge_nonce = nonces[d.first];
+        });
+    }
+
+    //update donations
+    for (const auto& t : totals) {
+        auto don = by_donor.lower_bound(t.first.first);
+        while (don != by_donor.end() && don->donor.value == t.first.first && don->project_name.value != t.first.second) {
+            don++;
+        }
+
+        if (don == by_donor.end() || don->donor.value != t.first.first) { //donation not found for project
+            new_donors[t.first.second] += 1;
+
+            donations.emplace(relayer, [&](auto& row) {
+                row.donation_id = donations.available_primary_key();
+                row.donor = name(t.first.first);
+                row.project_name = name(t.first.second);
+                row.total = t.second;
+            });
+        } else { //previous donation to project exists
+            by_donor.modify(don, same_payer, [&](auto& row) {
+                row.total += t.second;
+            });
+        }
+    }
+
+    //add pledges to projects, update status if now fully funded
+    for (const auto& c : credits) {
+        auto& proj = projects.get(c.first);
+        uint8_t new_status = proj.received + c.second >= proj.requested ? uint8_t(FUNDED) : proj.status;
+
+        projects.modify(proj, same_payer, [&](auto& row) {
+            row.received += c.second;
+            row.donations += new_donors[c.first];
+            row.status = new_status;
+        });
+    }
+
+    for (const auto& t : totals) {
+        auto& proj = projects.get(t.first.second);
+        emit_event(name("pledge"), name(t.first.second), name(t.first.first), t.second.amount, -t.second.amount, proj.status);
+    }
+}
+
+void grassroots::newrecur(name donor, name project_name, asset rate, uint32_t period, asset cap) {
+    //authenticate
+    require_auth(donor);
+
+    //get account
+    accounts_table accounts(get_self(), get_self().value);
+    auto& acc = accounts.get(donor.value, "account not registered");
+
+    //get project
+    projects_table projects(get_self(), get_self().value);
+    auto& proj = projects.get(project_name.value, "project not found");
+
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
+    //validate
+    check(proj.status == FUNDING, "project is not funding");
+    check(proj.end_time > now(), "project funding is over");
+    check(rate.symbol == CORE_SYM && cap.symbol == CORE_SYM, "can only pledge native currency");
+    check(rate > asset(0, CORE_SYM), "must pledge a positive rate");
+    check(cap >= rate, "cap must cover at least one period");
+    check(cap.amount % rate.amount == 0, "cap must be a whole number of periods");
+    check(period >= DAY_IN_SECS, "period must be at least one day");
+
+    //emplace recurring pledge, ram paid by donor
+    recurring_table recurring(get_self(), get_self().value);
+    recurring.emplace(donor, [&](auto& row) {
+        row.pledge_id = recurring.available_primary_key();
+        row.donor = donor;
+        row.project_name = project_name;
+        row.rate = rate;
+        row.period = period;
+        row.start_time = now();
+        row.cap = cap;
+        row.settled = asset(0, CORE_SYM);
+        row.last_settled = now();
+    });
+
+    emit_event(name("newrecur"), project_name, donor, 0, 0, proj.status);
+}
+
+void grassroots::cancelrecur(name donor, uint64_t pledge_id) {
+    //authenticate
+    require_auth(donor);
+
+    //get recurring pledge
+    recurring_table recurring(get_self(), get_self().value);
+    auto& rec = recurring.get(pledge_id, "recurring pledge not found");
+
+    //validate
+    check(rec.donor == donor, "cannot cancel another account's recurring pledge");
+
+    //settle periods already owed, erase pledge if settling didn't finish it
+    name project_name = rec.project_name;
+    if (!settle_recurring(recurring, rec, donor)) {
+        recurring.erase(rec);
+    }
+
+    projects_table projects(get_self(), get_self().value);
+    auto proj = projects.find(project_name.value);
+    emit_event(name("cancelrecur"), project_name, donor, 0, 0, proj == projects.end() ? uint8_t(SETUP) : proj->status);
+}
+
+void grassroots::settlerecur(name actor, uint64_t pledge_id) {
+    //authenticate
+    require_auth(actor);
+
+    //get recurring pledge
+    recurring_table recurring(get_self(), get_self().value);
+    auto& rec = recurring.get(pledge_id, "recurring pledge not found");
+
+    //get project creator, pledges to removed projects can be settled by anyone
+    projects_table projects(get_self(), get_self().value);
+    auto proj = projects.find(rec.project_name.value);
+    name creator = proj == projects.end() ? actor : proj->creator;
+
+    //validate
+    check(actor == rec.donor || actor == creator, "only the donor or project creator can settle");
+
+    settle_recurring(recurring, rec, actor);
+}
+
+void grassroots::settle(uint16_t max_rows) {
+    //validate
+    check(max_rows > 0, "must settle at least one row");
+
+    //collect due pledges first, settling moves them in the bynextdue index
+    recurring_table recurring(get_self(), get_self().value);
+    auto by_next_due = recurring.get_index<name("bynextdue")>();
+    vector<uint64_t> due;
+
+    for (auto itr = by_next_due.begin(); itr != by_next_due.end() && itr->by_next_due() <= now() && due.size() < max_rows; itr++) {
+        due.push_back(itr->pledge_id);
+    }
+
+    //settle due pledges, new donation ram paid by contract
+    for (auto pledge_id : due) {
+        settle_recurring(recurring, recurring.get(pledge_id), get_self());
+    }
 }
 
 void grassroots::withdraw(name account_name, asset amount) {
@@ -272,6 +577,9 @@ void grassroots::withdraw(name account_name, asset amount) {
     accounts_table accounts(get_self(), get_self().value);
     auto& acc = accounts.get(account_name.value, "account not found");
 
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
     //validate
     check(acc.balance >= amount, "insufficient balance");
     check(amount > asset(0, CORE_SYM), "must withdraw a positive amount");
@@ -289,6 +597,8 @@ void grassroots::withdraw(name account_name, asset amount) {
 		amount, //quantity
         std::string("grassroots withdrawal") //memo
 	)).send();
+
+    emit_event(name("withdraw"), name(0), account_name, 0, -amount.amount, 0);
 }
 
 void grassroots::deleteacct(name account_name) {
@@ -315,9 +625,15 @@ void grassroots::deleteacct(name account_name) {
         row.rewards += acc.rewards;
     });
 
-    //delete account
+    //delete account and pledge key
     accounts.erase(acc);
 
+    pledgekeys_table keys(get_self(), get_self().value);
+    auto key = keys.find(account_name.value);
+    if (key != keys.end()) {
+        keys.erase(key);
+    }
+
     //transfer remaining balance back to eosio.token
     //inline trx requires gograssroots@active to have gograssroots@eosio.code
     action(permission_level{get_self(), name("active")}, name("eosio.token"), name("transfer"), make_tuple(
@@ -326,6 +642,8 @@ void grassroots::deleteacct(name account_name) {
 		quantity, //quantity
         std::string("balance from deleted account") //memo
 	)).send();
+
+    emit_event(name("deleteacct"), name(0), account_name, 0, -quantity.amount, 0);
 }
 
 void grassroots::redeemroots(name account_name, name package_name, name project_name) {
@@ -336,6 +654,9 @@ void grassroots::redeemroots(name account_name, name package_name, name project_
     accounts_table accounts(get_self(), get_self().value);
     auto& acc = accounts.get(account_name.value, "account not found");
 
+    //rate limit
+    consume_rate_token(accounts, acc, same_payer);
+
     //process package
     if (package_name == name("addfeatured")) {
 
@@ -363,7 +684,152 @@ void grassroots::redeemroots(name account_name, name package_name, name project_
             });
         }
 
+        emit_event(name("redeemroots"), project_name, account_name, 0, 0, 0);
+    }
+}
+
+void grassroots::compactdons(name project_name, uint16_t max_rows) {
+    //get project
+    projects_table projects(get_self(), get_self().value);
+    auto& proj = projects.get(project_name.value, "project not found");
+
+    //validate
+    check(proj.end_time <= now(), "project funding is not over");
+
+    //project that ended while still funding missed its goal
+    if (proj.status == FUNDING) {
+        projects.modify(proj, same_payer, [&](auto& row) {
+            row.status = FAILED;
+        });
+    }
+
+    check(proj.status == FUNDED || proj.status == FAILED || proj.status == CANCELLED, 
+        "can only compact donations of finished projects");
+    check(max_rows > 0, "must compact at least one row");
+
+    //find or emplace donation root, ram paid by contract
+    donationroots_table roots(get_self(), get_self().value);
+    auto rt = roots.find(project_name.value);
+
+    if (rt == roots.end()) {
+        rt = roots.emplace(get_self(), [&](auto& row) {
+            row.project_name = project_name;
+            row.leaf_count = 0;
+            row.total = asset(0, CORE_SYM);
+            row.status = proj.status;
+            row.root = checksum256();
+            row.sealed = false;
+        });
+    }
+
+    check(!rt->sealed, "donations already compacted");
+
+    uint32_t leaf_count = rt->leaf_count;
+    asset total = rt->total;
+    vector<checksum256> branch = rt->branch;
+
+    //fold donations in donation_id order into the merkle frontier
+    donations_table donations(get_self(), get_self().value);
+    auto by_project = donations.get_index<name("byproject")>();
+    auto don = by_project.lower_bound(project_name.value);
+    uint16_t count = 0;
+
+    while (don != by_project.end() && don->project_name == project_name && count < max_rows) {
+        checksum256 node = donation_leaf(don->donation_id, don->donor, don->project_name, don->total);
+        total += don->total;
+        leaf_count += 1;
+
+        //insert leaf, carrying completed subtrees up the frontier
+        uint32_t size = leaf_count;
+        for (uint8_t h = 0; h < MERKLE_DEPTH; h++) {
+            if (branch.size() <= h) {
+                branch.resize(h + 1);
+            }
+
+            if (size & 1) {
+                branch[h] = node;
+                break;
+            }
+
+            node = hash_pair(branch[h], node);
+            size >>= 1;
+        }
+
+        don = by_project.erase(don);
+        count++;
+    }
+
+    bool done = don == by_project.end() || don->project_name != project_name;
+    checksum256 root = checksum256();
+
+    //compute final root, padding with zero subtrees
+    if (done) {
+        checksum256 zero = checksum256();
+        uint32_t size = leaf_count;
+
+        for (uint8_t h = 0; h < MERKLE_DEPTH; h++) {
+            if (size & 1) {
+                root = hash_pair(branch[h], root);
+            } else {
+                root = hash_pair(root, zero);
+            }
+
+            zero = hash_pair(zero, zero);
+            size >>= 1;
+        }
+
+        branch.clear();
+    }
+
+    //update donation root
+    roots.modify(rt, same_payer, [&](auto& row) {
+        row.leaf_count = leaf_count;
+        row.total = total;
+        row.branch = branch;
+        row.root = root;
+        row.sealed = done;
+    });
+
+    emit_event(name("compactdons"), project_name, name(0), 0, 0, proj.status);
+}
+
+void grassroots::claimproof(name project_name, name donor, uint64_t donation_id, asset total,
+    uint32_t leaf_index, vector<checksum256> proof) {
+    //authenticate
+    require_auth(donor);
+
+    //get donation root
+    donationroots_table roots(get_self(), get_self().value);
+    auto& rt = roots.get(project_name.value, "donation root not found");
+
+    //validate
+    check(rt.sealed, "donations are still being compacted");
+    check(leaf_index < rt.leaf_count, "leaf index out of range");
+    check(proof.size() == MERKLE_DEPTH, "proof must have one node per tree level");
+
+    //walk proof from leaf to root
+    checksum256 node = donation_leaf(donation_id, donor, project_name, total);
+
+    for (uint8_t h = 0; h < MERKLE_DEPTH; h++) {
+        if ((leaf_index >> h) & 1) {
+            node = hash_pair(proof[h], node);
+        } else {
+            node = hash_pair(node, proof[h]);
+        }
     }
+
+    check(node == rt.root, "invalid donation proof");
+
+    //record claim, ram paid by donor
+    claims_table claims(get_self(), project_name.value);
+    check(claims.find(leaf_index) == claims.end(), "donation already claimed");
+
+    claims.emplace(donor, [&](auto& row) {
+        row.leaf_index = leaf_index;
+        row.donor = donor;
+    });
+
+    emit_event(name("claimproof"), project_name, donor, 0, 0, rt.status);
 }
 
 //======================== order actions ========================
@@ -381,8 +847,17 @@ void grassroots::suspendacct(name account_to_suspend, string memo) {
     auto& acc = accounts.get(account_to_suspend.value, "account not found");
 
     //validate
+    check(!acc.suspended.value_or(), "account is already suspended");
+
+    //suspend account, ram growth from upgrading is paid by contract
+    name payer = acc.needs_upgrade() ? get_self() : same_payer;
+    accounts.modify(acc, payer, [&](auto& row) {
+        row.upgrade();
+        row.bucket.emplace(0);
+        row.suspended.emplace(true);
+    });
 
-    //TODO: 
+    emit_event(name("suspendacct"), name(0), account_to_suspend, 0, 0, 0);
 }
 
 void grassroots::restoreacct(name account_to_restore, string memo) {
@@ -394,8 +869,15 @@ void grassroots::restoreacct(name account_to_restore, string memo) {
     auto &acc = accounts.get(account_to_restore.value, "account not found");
 
     //validate
+    check(acc.suspended.value_or(), "account is not suspended");
 
-    //TOD: 
+    //restore account, bucket refills on next action
+    accounts.modify(acc, same_payer, [&](auto& row) {
+        row.last_refill.emplace(0);
+        row.suspended.emplace(false);
+    });
+
+    emit_event(name("restoreacct"), name(0), account_to_restore, 0, 0, 0);
 }
 
 void grassroots::addcategory(name new_category) {
@@ -413,6 +895,8 @@ void grassroots::addcategory(name new_category) {
     categories.emplace(ADMIN_NAME, [&](auto& row) {
         row.category_name = new_category;
     });
+
+    emit_event(name("addcategory"), name(0), ADMIN_NAME, 0, 0, 0);
 }
 
 void grassroots::rmvcategory(name category) {
@@ -425,6 +909,116 @@ void grassroots::rmvcategory(name category) {
 
     //remove category
     categories.erase(cat);
+
+    emit_event(name("rmvcategory"), name(0), ADMIN_NAME, 0, 0, 0);
+}
+
+void grassroots::setratelimit(uint16_t bucket_capacity, uint32_t refill_secs) {
+    //authenticate
+    require_auth(ADMIN_NAME);
+
+    //validate
+    check(refill_secs > 0, "refill seconds must be positive");
+
+    //set config
+    config_singleton configs(get_self(), get_self().value);
+    configs.set(config{bucket_capacity, refill_secs}, get_self());
+
+    emit_event(name("setratelimit"), name(0), ADMIN_NAME, 0, 0, 0);
+}
+
+void grassroots::setchainid(checksum256 chain_id) {
+    //authenticate
+    require_auth(ADMIN_NAME);
+
+    //validate
+    check(chain_id != checksum256(), "chain id cannot be empty");
+
+    //set chain id
+    chaininfo_singleton chain(get_self(), get_self().value);
+    chain.set(chaininfo{chain_id}, get_self());
+
+    emit_event(name("setchainid"), name(0), ADMIN_NAME, 0, 0, 0);
+}
+
+void grassroots::archive(uint16_t max_rows) {
+    //authenticate
+    require_auth(ADMIN_NAME);
+
+    //validate
+    check(max_rows > 0, "must scan at least one row");
+
+    //get tables
+    projects_table projects(get_self(), get_self().value);
+    auto by_end_time = projects.get_index<name("byendtime")>();
+    archived_table archives(get_self(), get_self().value);
+    donations_table donations(get_self(), get_self().value);
+    auto by_project = donations.get_index<name("byproject")>();
+
+    //resume after last scanned project, skipping SETUP projects with no end time
+    archcursor_singleton cursor(get_self(), get_self().value);
+    auto last = cursor.get_or_default(archcursor{0, name(0)});
+    auto proj = by_end_time.lower_bound(last.end_time > 0 ? last.end_time : 1);
+
+    //projects with equal end times are ordered by project name
+    while (proj != by_end_time.end() && proj->end_time == last.end_time && proj->project_name.value <= last.project_name.value) {
+        proj++;
+    }
+
+    //scan ended projects oldest first
+    uint16_t count = 0;
+
+    while (proj != by_end_time.end() && proj->end_time + ARCHIVE_DELAY <= now() && count < max_rows) {
+        count++;
+        last.end_time = proj->end_time;
+        last.project_name = proj->project_name;
+
+        //only archive projects whose donations have been compacted
+        auto don = by_project.find(proj->project_name.value);
+
+        if (don != by_project.end()) {
+            proj++;
+            continue;
+        }
+
+        auto data = pack(*proj);
+        name project_name = proj->project_name;
+        name creator = proj->creator;
+
+        //every scanned project has ended, one still funding missed its goal
+        uint8_t status = proj->status == FUNDING ? uint8_t(FAILED) : proj->status;
+
+        //emplace archived summary, ram paid by contract
+        archives.emplace(get_self(), [&](auto& row) {
+            row.project_name = project_name;
+            row.creator = creator;
+            row.received = proj->received;
+            row.status = status;
+            row.content_hash = sha256(data.data(), data.size());
+        });
+
+        //remove tags and project
+        set_project_tags(project_name, creator, proj->tags.value_or(), vector<name>());
+        proj = by_end_time.erase(proj);
+
+        emit_event(name("archive"), project_name, creator, 0, 0, status);
+    }
+
+    //restart from the oldest project once the scan reaches recent projects, ram paid by contract
+    if (proj == by_end_time.end() || proj->end_time + ARCHIVE_DELAY > now()) {
+        if (cursor.exists()) {
+            cursor.remove();
+        }
+    } else {
+        cursor.set(last, get_self());
+    }
+}
+
+//========== event actions ==========
+
+void grassroots::log(event evt) {
+    //authenticate, only emitted inline by the contract itself
+    require_auth(get_self());
 }
 
 //========== functions ==========
@@ -445,18 +1039,234 @@ bool grassroots::is_valid_category(name category) {
     return cat != categories.end();
 }
 
+void grassroots::set_project_tags(name project_name, name payer, const vector<name>& old_tags, const vector<name>& new_tags) {
+    //validate
+    check(new_tags.size() <= MAX_TAGS, "too many tags");
+
+    for (size_t i = 0; i < new_tags.size(); i++) {
+        check(new_tags[i] != name(0), "tag cannot be blank");
+
+        for (size_t j = 0; j < i; j++) {
+            check(new_tags[i] != new_tags[j], "duplicate tag");
+        }
+    }
+
+    //get tags table
+    tags_table tags(get_self(), get_self().value);
+    auto by_tag_proj = tags.get_index<name("bytagproj")>();
+
+    //erase tags no longer on the project
+    for (auto t : old_tags) {
+        if (std::find(new_tags.begin(), new_tags.end(), t) == new_tags.end()) {
+            auto itr = by_tag_proj.find((uint128_t(t.value) << 64) | project_name.value);
+
+            if (itr != by_tag_proj.end()) {
+                by_tag_proj.erase(itr);
+            }
+        }
+    }
+
+    //emplace tags new to the project
+    for (auto t : new_tags) {
+        if (std::find(old_tags.begin(), old_tags.end(), t) == old_tags.end()) {
+            tags.emplace(payer, [&](auto& row) {
+                row.tag_id = tags.available_primary_key();
+                row.tag_name = t;
+                row.project_name = project_name;
+            });
+        }
+    }
+}
+
+uint8_t grassroots::add_donation(name donor, name project_name, asset amount, name payer) {
+    //get project
+    projects_table projects(get_self(), get_self().value);
+    auto& proj = projects.get(project_name.value, "project not found");
+
+    //find donor's donation to project
+    donations_table donations(get_self(), get_self().value);
+    auto by_donor = donations.get_index<name("bydonor")>();
+    auto don = by_donor.lower_bound(donor.value);
+
+    while (don != by_donor.end() && don->donor == donor && don->project_name != project_name) {
+        don++;
+    }
+
+    uint32_t new_donors = 0;
+
+    //update donations
+    if (don == by_donor.end() || don->donor != donor) { //donation not found for project
+        new_donors = 1;
+
+        donations.emplace(payer, [&](auto& row) {
+            row.donation_id = donations.available_primary_key();
+            row.donor = donor;
+            row.project_name = project_name;
+            row.total = amount;
+        });
+    } else { //previous donation to project exists
+        by_donor.modify(don, same_payer, [&](auto& row) {
+            row.total += amount;
+        });
+    }
+
+    //update project status if now fully funded
+    uint8_t new_status = proj.received + amount >= proj.requested ? uint8_t(FUNDED) : proj.status;
+
+    //add donation to project
+    projects.modify(proj, same_payer, [&](auto& row) {
+        row.received += amount;
+        row.donations += new_donors;
+        row.status = new_status;
+    });
+
+    return new_status;
+}
+
+bool grassroots::settle_recurring(recurring_table& recurring, const recurpledge& rec, name payer) {
+    //get account, pledges of deleted accounts are erased
+    accounts_table accounts(get_self(), get_self().value);
+    auto acc = accounts.find(rec.donor.value);
+
+    //get project, only projects still funding accept pledges
+    projects_table projects(get_self(), get_self().value);
+    auto proj = projects.find(rec.project_name.value);
+    bool open = acc != accounts.end() && proj != projects.end() && 
+        proj->status == FUNDING && proj->end_time > now();
+
+    //accrue whole periods until now, nothing is paid after funding ends
+    uint64_t periods = open && now() > rec.last_settled ? (now() - rec.last_settled) / rec.period : 0;
+
+    //pay what the cap and balance allow, periods the balance can't cover are skipped
+    uint64_t cap_periods = (rec.cap - rec.settled).amount / rec.rate.amount;
+    uint64_t balance_periods = !open || acc->suspended.value_or() ? 0 : acc->balance.amount / rec.rate.amount;
+    uint64_t paid = std::min(periods, std::min(cap_periods, balance_periods));
+    asset amount = rec.rate * int64_t(paid);
+
+    bool finished = !open || rec.settled + amount >= rec.cap;
+
+    //save pledge for event, can't read rec after erase
+    name donor = rec.donor;
+    name project_name = rec.project_name;
+    uint8_t new_status = proj == projects.end() ? uint8_t(SETUP) : proj->status;
+
+    if (paid > 0) {
+        //subtract settled periods from balance
+        accounts.modify(acc, same_payer, [&](auto& row) {
+            row.balance -= amount;
+        });
+
+        new_status = add_donation(donor, project_name, amount, payer);
+    }
+
+    //erase finished pledge or advance past every accrued period, so unpayable pledges don't stay due
+    if (finished) {
+        recurring.erase(rec);
+    } else if (periods > 0) {
+        recurring.modify(rec, same_payer, [&](auto& row) {
+            row.settled += amount;
+            row.last_settled += uint32_t(periods * rec.period);
+        });
+    }
+
+    //emit for every settlement that changed the pledge, including skipped periods
+    if (finished || periods > 0) {
+        emit_event(name("recurring"), project_name, donor, amount.amount, -amount.amount, new_status);
+    }
+
+    return finished;
+}
+
+void grassroots::consume_rate_token(accounts_table& accounts, const account& acc, name upgrade_payer) {
+    //validate
+    check(!acc.suspended.value_or(), "account is suspended");
+
+    //admin is never rate limited
+    if (acc.account_name == ADMIN_NAME) {
+        return;
+    }
+
+    //get config
+    config_singleton configs(get_self(), get_self().value);
+    auto conf = configs.get_or_default(config{DEFAULT_BUCKET_CAPACITY, DEFAULT_REFILL_SECS});
+
+    //rate limiting disabled
+    if (conf.bucket_capacity == 0) {
+        return;
+    }
+
+    //refill bucket for elapsed time, keeping partial refill progress
+    uint32_t last_refill = acc.last_refill.value_or();
+    uint32_t refills = (now() - last_refill) / conf.refill_secs;
+    uint64_t tokens = uint64_t(acc.bucket.value_or()) + refills;
+    uint32_t new_last_refill = last_refill + refills * conf.refill_secs;
+
+    if (tokens >= conf.bucket_capacity) {
+        tokens = conf.bucket_capacity;
+        new_last_refill = now();
+    }
+
+    check(tokens > 0, "rate limit exceeded, try again later");
+
+    //spend token, legacy rows grow at upgrade_payer's expense
+    name payer = acc.needs_upgrade() ? upgrade_payer : same_payer;
+    accounts.modify(acc, payer, [&](auto& row) {
+        row.upgrade();
+        row.bucket.emplace(uint16_t(tokens - 1));
+        row.last_refill.emplace(new_last_refill);
+    });
+}
+
+checksum256 grassroots::donation_leaf(uint64_t donation_id, name donor, name project_name, asset total) {
+    auto data = pack(make_tuple(donation_id, donor, project_name, total));
+    return sha256(data.data(), data.size());
+}
+
+checksum256 grassroots::hash_pair(const checksum256& left, const checksum256& right) {
+    auto data = pack(make_tuple(left, right));
+    return sha256(data.data(), data.size());
+}
+
+void grassroots::emit_event(name event_type, name project_name, name account_name,
+    int64_t received_delta, int64_t balance_delta, uint8_t status) {
+    event evt = {
+        EVENT_VERSION,
+        event_type,
+        project_name,
+        account_name,
+        received_delta,
+        balance_delta,
+        status
+    };
+
+    //inline trx requires gograssroots@active to have gograssroots@eosio.code
+    action(permission_level{get_self(), name("active")}, get_self(), name("log"), make_tuple(
+        evt
+    )).send();
+}
+
 //========== reactions ==========
 
 void grassroots::catch_transfer(name from, name to, asset quantity, string memo) {
+    //ignore outgoing transfers, such as withdrawals
+    if (to != get_self() || from == get_self()) {
+        return;
+    }
+
     //check for account
     accounts_table accounts(get_self(), get_self().value);
     auto acc = accounts.find(from.value);
 
     if (acc != accounts.end()) { //account is already registered
+        //rate limit
+        consume_rate_token(accounts, *acc, get_self());
+
         //update balance
         accounts.modify(acc, same_payer, [&](auto& row) {
             row.balance += quantity;
         });
+
+        emit_event(name("deposit"), name(0), from, 0, quantity.amount, 0);
     } else if (acc == accounts.end() && memo == "register account") { //register new account
         //check amount covers fee
         check(quantity >= RAM_FEE, "must transfer at least 0.1 TLOS to cover ram fee");
@@ -466,28 +1276,54 @@ void grassroots::catch_transfer(name from, name to, asset quantity, string memo)
             row.account_name = from;
             row.balance = quantity - RAM_FEE;
             row.rewards = asset(0, ROOTS_SYM);
+            row.upgrade();
         });
+
+        emit_event(name("registeracct"), name(0), from, 0, (quantity - RAM_FEE).amount, 0);
     }
 }
 
 //========== migration actions ==========
 
 void grassroots::rmvaccount(name account_name) {
+    //authenticate
+    require_auth(ADMIN_NAME);
+
     accounts_table accounts(get_self(), get_self().value);
     auto& acc = accounts.get(account_name.value, "account not found");
+    int64_t balance = acc.balance.amount;
     accounts.erase(acc);
+
+    emit_event(name("rmvaccount"), name(0), account_name, 0, -balance, 0);
 }
 
 void grassroots::rmvproject(name project_name) {
+    //authenticate
+    require_auth(ADMIN_NAME);
+
     projects_table projects(get_self(), get_self().value);
     auto& proj = projects.get(project_name.value, "project not found");
+    int64_t received = proj.received.amount;
+    uint8_t status = proj.status;
+
+    //remove tags and project
+    set_project_tags(project_name, proj.creator, proj.tags.value_or(), vector<name>());
     projects.erase(proj);
+
+    emit_event(name("rmvproject"), project_name, name(0), -received, 0, status);
 }
 
 void grassroots::rmvdonation(uint64_t donation_id) {
+    //authenticate
+    require_auth(ADMIN_NAME);
+
     donations_table donations(get_self(), get_self().value);
     auto& don = donations.get(donation_id, "donation not found");
+    name project_name = don.project_name;
+    name donor = don.donor;
     donations.erase(don);
+
+    emit_event(name("rmvdonation"), project_name, donor, 0, 0, 0);
 }
 
 //========== dispatcher ==========
@@ -511,8 +1347,12 @@ extern "C"
             {
                 EOSIO_DISPATCH_HELPER(grassroots, 
                     (newproject)(updateproj)(openfunding)(cancelproj)(deleteproj)
-                    (registeracct)(donate)(undonate)(withdraw)(deleteacct)(redeemroots)
-                    (suspendacct)(restoreacct)(addcategory)(rmvcategory)
+                    (registeracct)(donate)(undonate)(setpledgekey)(settlepledges)
+                    (newrecur)(cancelrecur)(settlerecur)(settle)
+                    (withdraw)(deleteacct)(redeemroots)
+                    (compactdons)(claimproof)
+                    (suspendacct)(restoreacct)(addcategory)(rmvcategory)(setratelimit)(setchainid)(archive)
+                    (log)
                     (rmvaccount)(rmvproject)(rmvdonation));
             }
 
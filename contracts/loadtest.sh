@@ -0,0 +1,215 @@
+#! /bin/bash
+
+# Load test for the grassroots contract against a local single-node chain.
+#
+# usage: ./loadtest.sh [accounts] [projects] [actions] [actions_per_sec]
+#
+# Requires nodeos, cleos, keosd, jq, bc and g++ on the PATH, and EOSIO_CONTRACTS set to
+# a build of eosio.contracts containing eosio.token. Runs fully offline.
+#
+# Besides per-action cpu and net, reports the time spent in the inline log events
+# (log_us), the native decode rate of the emitted events and the wall time of
+# tagquery.sh lookups over the tagged test projects.
+
+accounts=${1:-20}
+projects=${2:-5}
+actions=${3:-500}
+rate=${4:-10}
+
+if [[ -z "$EOSIO_CONTRACTS" ]]; then
+    echo "need EOSIO_CONTRACTS"
+    exit 1
+fi
+
+#build.sh and deploy.sh use paths relative to contracts/
+cd "$(dirname "$0")"
+
+workdir=$(mktemp -d /tmp/grassroots-loadtest.XXXX)
+url=http://127.0.0.1:8888
+wallet_url=http://127.0.0.1:8899
+
+#eosio development key
+pub_key=EOS6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV
+priv_key=5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3
+
+cleos="cleos -u $url --wallet-url $wallet_url"
+
+cleanup() {
+    kill $nodeos_pid $keosd_pid 2>/dev/null
+    wait 2>/dev/null
+}
+trap cleanup EXIT
+
+#========== chain ==========
+
+keosd --http-server-address 127.0.0.1:8899 --wallet-dir $workdir/wallet \
+    --unlock-timeout 999999 > $workdir/keosd.log 2>&1 &
+keosd_pid=$!
+
+nodeos -e -p eosio --data-dir $workdir/data --config-dir $workdir/config \
+    --plugin eosio::producer_plugin --plugin eosio::chain_api_plugin --plugin eosio::http_plugin \
+    --http-server-address 127.0.0.1:8888 --max-transaction-time 1000 \
+    --contracts-console > $workdir/nodeos.log 2>&1 &
+nodeos_pid=$!
+
+sleep 3
+
+$cleos wallet create --to-console > /dev/null
+$cleos wallet import --private-key $priv_key > /dev/null
+
+#========== setup ==========
+
+#converts an index to a valid account name suffix
+to_name() {
+    local i=$1
+    local out=""
+    for n in 1 2 3 4 5 6; do
+        out=$(printf "\\x$(printf %x $((97 + i % 26)))")$out
+        i=$((i / 26))
+    done
+    echo $out
+}
+
+#prints a json array of two distinct tags from the tag pool
+tag_pool=(games music art film tech)
+random_tags() {
+    local a=$((RANDOM % ${#tag_pool[@]}))
+    local b=$(((a + 1 + RANDOM % (${#tag_pool[@]} - 1)) % ${#tag_pool[@]}))
+    echo '["'${tag_pool[$a]}'", "'${tag_pool[$b]}'"]'
+}
+
+$cleos create account eosio eosio.token $pub_key > /dev/null
+$cleos create account eosio gograssroots $pub_key > /dev/null
+$cleos set contract eosio.token $EOSIO_CONTRACTS/eosio.token > /dev/null
+$cleos push action eosio.token create '["eosio", "1000000000.0000 TLOS"]' -p eosio.token > /dev/null
+
+#inline transfers and log events require gograssroots@eosio.code
+$cleos set account permission gograssroots active \
+    '{"threshold": 1, "keys": [{"key": "'$pub_key'", "weight": 1}], "accounts": [{"permission": {"actor": "gograssroots", "permission": "eosio.code"}, "weight": 1}]}' \
+    owner -p gograssroots > /dev/null
+
+./build.sh grassroots || { echo "build failed"; exit 1; }
+WALLET_URL=$wallet_url ./deploy.sh grassroots local > /dev/null || { echo "deploy failed"; exit 1; }
+
+#capacity high enough never to throttle the test, while still measuring the rate limit
+$cleos push action gograssroots setratelimit '[65535, 1]' -p gograssroots > /dev/null
+$cleos push action gograssroots addcategory '["apps"]' -p gograssroots > /dev/null
+$cleos push action gograssroots registeracct '["gograssroots"]' -p gograssroots > /dev/null
+
+for ((i = 0; i < accounts; i++)); do
+    acct=lt$(to_name $i)
+    $cleos create account eosio $acct $pub_key > /dev/null
+    $cleos push action eosio.token issue '["'$acct'", "10000.0000 TLOS", ""]' -p eosio > /dev/null
+    $cleos push action gograssroots registeracct '["'$acct'"]' -p $acct > /dev/null
+    $cleos transfer $acct gograssroots "1000.0000 TLOS" "" -p $acct > /dev/null
+done
+
+for ((i = 0; i < projects; i++)); do
+    proj=lp$(to_name $i)
+    creator=lt$(to_name $((i % accounts)))
+    $cleos push action gograssroots newproject \
+        '["'$proj'", "apps", "'$creator'", "load test", "load test project", "100000000.0000 TLOS", '"$(random_tags)"']' \
+        -p $creator > /dev/null
+    $cleos push action gograssroots openfunding '["'$proj'", "'$creator'", 180]' -p $creator > /dev/null
+done
+
+#========== traffic ==========
+
+tables="projects accounts donations donroots tags archived recurring"
+
+row_count() {
+    $cleos get table gograssroots gograssroots $1 -l 100000 | jq '.rows | length'
+}
+
+ram_usage() {
+    $cleos get account gograssroots --json | jq '.ram_usage'
+}
+
+declare -A rows_before
+for table in $tables; do
+    rows_before[$table]=$(row_count $table)
+done
+ram_before=$(ram_usage)
+
+results=$workdir/results.txt
+failures=$workdir/failures.txt
+touch $results $failures
+
+for ((i = 0; i < actions; i++)); do
+    acct=lt$(to_name $((RANDOM % accounts)))
+    p=$((RANDOM % projects))
+    proj=lp$(to_name $p)
+
+    case $((RANDOM % 5)) in
+        0) act=transfer
+           trx=$($cleos transfer $acct gograssroots "1.0000 TLOS" "" -p $acct --json 2>/dev/null) ;;
+        1) act=donate
+           trx=$($cleos push action gograssroots donate '["'$proj'", "'$acct'", "1.0000 TLOS", ""]' \
+               -p $acct --json 2>/dev/null) ;;
+        2) act=undonate
+           trx=$($cleos push action gograssroots undonate '["'$proj'", "'$acct'", ""]' \
+               -p $acct --json 2>/dev/null) ;;
+        3) act=withdraw
+           trx=$($cleos push action gograssroots withdraw '["'$acct'", "1.0000 TLOS"]' \
+               -p $acct --json 2>/dev/null) ;;
+        4) act=updateproj
+           creator=lt$(to_name $((p % accounts)))
+           trx=$($cleos push action gograssroots updateproj \
+               '["'$proj'", "'$creator'", "load test", "load test project", "https://example.com", "100000000.0000 TLOS", '"$(random_tags)"']' \
+               -p $creator --json 2>/dev/null) ;;
+    esac
+
+    #failed actions, such as undonate without a donation, are only counted
+    if [[ -z "$trx" ]]; then
+        echo "$act" >> $failures
+    else
+        echo "$trx" | jq -r --arg act $act \
+            '"\($act) \(.processed.receipt.cpu_usage_us) \(.processed.receipt.net_usage_words * 8) \([.. | objects | select(.act?.name == "log") | .elapsed] | add // 0)"' >> $results
+        echo "$trx" | jq -r '.. | objects | select(.act?.name == "log") | .act.hex_data' >> $workdir/events.txt
+    fi
+
+    sleep $(echo "scale=3; 1 / $rate" | bc)
+done
+
+#========== report ==========
+
+percentile() {
+    sort -n | awk -v p=$1 '{ v[NR] = $1 } END { i = int((NR - 1) * p / 100) + 1; print v[i] }'
+}
+
+printf "\n%-10s %6s %6s %8s %8s %8s %8s %8s %8s %8s %8s\n" action count failed cpu_p50 cpu_p90 cpu_p99 cpu_max net_p50 net_p99 log_p50 log_p99
+for act in transfer donate undonate withdraw updateproj; do
+    count=$(grep -c "^$act " $results)
+    failed=$(grep -c "^$act\$" $failures)
+    if [[ $count -eq 0 ]]; then
+        printf "%-10s %6s %6s\n" $act 0 $failed
+        continue
+    fi
+    cpu() { grep "^$act " $results | cut -d ' ' -f 2; }
+    net() { grep "^$act " $results | cut -d ' ' -f 3; }
+    log() { grep "^$act " $results | cut -d ' ' -f 4; }
+    printf "%-10s %6s %6s %8s %8s %8s %8s %8s %8s %8s %8s\n" $act $count $failed \
+        $(cpu | percentile 50) $(cpu | percentile 90) $(cpu | percentile 99) $(cpu | percentile 100) \
+        $(net | percentile 50) $(net | percentile 99) $(log | percentile 50) $(log | percentile 99)
+done
+
+#decode every emitted event natively, reports events/s on stderr
+g++ -std=c++17 -O2 -o $workdir/eventdecode tools/eventdecode.cpp
+printf "\nevents: "
+$workdir/eventdecode $workdir/events.txt 2>&1 > $workdir/events.json
+
+printf "\n%-10s %8s %8s\n" table rows_before rows_after
+for table in $tables; do
+    printf "%-10s %8s %8s\n" $table ${rows_before[$table]} $(row_count $table)
+done
+
+#time host-side tag intersections against the final tags table
+printf "\n%-20s %8s %8s\n" tags matches ms
+for tags in "games" "games music" "art film tech"; do
+    start=$(date +%s%N)
+    matches=$(./tagquery.sh $url $tags | grep -c .)
+    printf "%-20s %8s %8s\n" "$tags" $matches $((($(date +%s%N) - start) / 1000000))
+done
+
+printf "\ngograssroots ram_usage: %s -> %s bytes\n" $ram_before $(ram_usage)
+echo "cpu and log in us, net in bytes, raw results in $results, decoded events in $workdir/events.json"
@@ -0,0 +1,54 @@
+#! /bin/bash
+
+# Lists projects carrying every given tag by intersecting one tags range scan per tag.
+#
+# usage: ./tagquery.sh <url> <tag> [tag...]
+#
+# Requires cleos, jq and bc on the PATH.
+
+if [[ $# -lt 2 ]]; then
+    echo "need url and at least one tag"
+    exit 0
+fi
+
+url=$1
+shift
+
+#converts an eosio name to its uint64 value as 16 upper case hex digits
+name_to_hex() {
+    local str=$1
+    local value=0
+    for ((i = 0; i < ${#str} && i < 13; i++)); do
+        local c=${str:$i:1}
+        local sym=0
+        if [[ $c =~ [a-z] ]]; then
+            sym=$(( $(printf %d "'$c") - 97 + 6 ))
+        elif [[ $c =~ [1-5] ]]; then
+            sym=$(( c ))
+        fi
+        if [[ $i -lt 12 ]]; then
+            value=$(( value | ((sym & 0x1f) << (64 - 5 * (i + 1))) ))
+        else
+            value=$(( value | (sym & 0x0f) ))
+        fi
+    done
+    printf %016X $value
+}
+
+#prints the sorted project names tagged with a tag
+tagged_projects() {
+    local hex=$(name_to_hex $1)
+    local lower=$(echo "ibase=16; ${hex}0000000000000000" | bc | tr -d '\\\n')
+    local upper=$(echo "ibase=16; ${hex}FFFFFFFFFFFFFFFF" | bc | tr -d '\\\n')
+    cleos -u $url get table gograssroots gograssroots tags --index 2 --key-type i128 \
+        --lower $lower --upper $upper -l 100000 | jq -r '.rows[].project_name' | sort
+}
+
+result=$(tagged_projects $1)
+shift
+
+for tag in "$@"; do
+    result=$(comm -12 <(echo "$result") <(tagged_projects $tag))
+done
+
+echo "$result"
@@ -0,0 +1,95 @@
+/**
+ * Decodes grassroots::log events and prints one JSON object per line.
+ *
+ * Reads the hex_data of one log action per line, for example from
+ * `jq -r '.. | objects | select(.act?.name == "log") | .act.hex_data'` over action
+ * traces, and reports decode throughput in events/s when done.
+ *
+ * build: g++ -std=c++17 -O2 -o eventdecode eventdecode.cpp
+ * usage: ./eventdecode [events_file]
+ *
+ * @author Craig Branscom
+ * @contract grassroots
+ * @copyright defined in LICENSE.txt
+ */
+
+#include "eventdecoder.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+bool hex_to_bytes(const string& hex, vector<uint8_t>& bytes) {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+
+    bytes.resize(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        int hi = nibble(hex[2 * i]);
+        int lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        bytes[i] = uint8_t((hi << 4) | lo);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ifstream file;
+    if (argc > 1) {
+        file.open(argv[1]);
+        if (!file) {
+            cerr << "cannot open " << argv[1] << endl;
+            return 1;
+        }
+    }
+    istream& in = argc > 1 ? file : cin;
+
+    string line;
+    vector<uint8_t> bytes;
+    uint64_t events = 0;
+    auto start = chrono::steady_clock::now();
+
+    try {
+        while (getline(in, line)) {
+            size_t first = line.find_first_not_of(" \t\"");
+            size_t last = line.find_last_not_of(" \t\r\",");
+            if (first == string::npos) {
+                continue;
+            }
+
+            if (!hex_to_bytes(line.substr(first, last - first + 1), bytes)) {
+                throw runtime_error("invalid hex on line " + to_string(events + 1));
+            }
+
+            auto evt = grassroots_events::decode(bytes.data(), bytes.size());
+            cout << "{\"version\":" << int(evt.version)
+                << ",\"event_type\":\"" << grassroots_events::name_to_string(evt.event_type)
+                << "\",\"project_name\":\"" << grassroots_events::name_to_string(evt.project_name)
+                << "\",\"account_name\":\"" << grassroots_events::name_to_string(evt.account_name)
+                << "\",\"received_delta\":" << evt.received_delta
+                << ",\"balance_delta\":" << evt.balance_delta
+                << ",\"status\":" << int(evt.status) << "}\n";
+            events++;
+        }
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return 1;
+    }
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << events << " events in " << secs << " s, " << uint64_t(secs > 0 ? events / secs : 0) << " events/s" << endl;
+    return 0;
+}
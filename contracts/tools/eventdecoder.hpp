@@ -0,0 +1,67 @@
+/**
+ * Native decoder for the fixed-layout events carried by grassroots::log.
+ *
+ * Decodes the packed action data of a log action, as found in the hex_data of an
+ * action trace, without an ABI. Has no dependencies beyond the standard library.
+ *
+ * @author Craig Branscom
+ * @contract grassroots
+ * @copyright defined in LICENSE.txt
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace grassroots_events {
+
+    //packed size of a version 1 event
+    const size_t EVENT_SIZE = 42;
+
+    struct event {
+        uint8_t version;
+        uint64_t event_type;
+        uint64_t project_name;
+        uint64_t account_name;
+        int64_t received_delta;
+        int64_t balance_delta;
+        uint8_t status; //only meaningful when project_name is set
+    };
+
+    //decodes a packed event, throws on short data or an unknown version
+    inline event decode(const uint8_t* data, size_t size) {
+        if (size < EVENT_SIZE) {
+            throw std::runtime_error("event too short");
+        }
+
+        event evt;
+        evt.version = data[0];
+        if (evt.version != 1) {
+            throw std::runtime_error("unknown event version " + std::to_string(evt.version));
+        }
+
+        memcpy(&evt.event_type, data + 1, 8);
+        memcpy(&evt.project_name, data + 9, 8);
+        memcpy(&evt.account_name, data + 17, 8);
+        memcpy(&evt.received_delta, data + 25, 8);
+        memcpy(&evt.balance_delta, data + 33, 8);
+        evt.status = data[41];
+        return evt;
+    }
+
+    //returns the string form of an eosio name
+    inline std::string name_to_string(uint64_t value) {
+        static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+        std::string str(13, '.');
+        uint64_t tmp = value;
+        for (int i = 0; i <= 12; i++) {
+            str[12 - i] = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+            tmp >>= (i == 0 ? 4 : 5);
+        }
+        size_t last = str.find_last_not_of('.');
+        return last == std::string::npos ? "" : str.substr(0, last + 1);
+    }
+
+}
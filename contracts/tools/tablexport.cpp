@@ -0,0 +1,492 @@
+/**
+ * Streams packed grassroots table rows into column-oriented files for analytics.
+ *
+ * Reads the json output of `cleos get table gograssroots gograssroots <table> --binary`,
+ * or one hex encoded row per line. Each row is decoded with a layout copied by hand from
+ * grassroots.hpp, which must be kept in sync with the contract; a row with bytes left
+ * over after decoding is rejected. Rows written before a binary extension field was
+ * added simply end early, and the field is exported as its default. Rows are never held
+ * in memory; every field is appended to its column file as it is decoded.
+ *
+ * cleos returns 10 rows unless -l is given. Concatenated pages are read one after another
+ * into the same columns, so a whole table is exported in one run:
+ *
+ *     key=""
+ *     while page=$(cleos get table gograssroots gograssroots accounts --binary -l 1000 -L "$key"); do
+ *         echo "$page"
+ *         [[ $(jq .more <<< "$page") == true ]] || break
+ *         key=$(jq -r .next_key <<< "$page")
+ *     done | ./tablexport accounts accounts_out
+ *
+ * Column encodings:
+ *     .dict.col  name and symbol columns, varint codes into the matching .dict file
+ *     .delta.col amount columns, zigzag varint deltas from the previous row
+ *     .var.col   integer columns, varints
+ *     .str.col   string columns, varint length followed by the bytes
+ *
+ * build: g++ -std=c++17 -O2 -o tablexport tablexport.cpp
+ * usage: ./tablexport <projects|accounts|donations> <out_dir> [rows_file]
+ *
+ * @author Craig Branscom
+ * @contract grassroots
+ * @copyright defined in LICENSE.txt
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//========== decoding ==========
+
+struct row_reader {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    size_t remaining() const { return end - pos; }
+
+    template<typename T>
+    T read() {
+        if (remaining() < sizeof(T)) {
+            throw runtime_error("row too short");
+        }
+        T value;
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    uint64_t read_varuint() {
+        uint64_t value = 0;
+        uint8_t shift = 0;
+        uint8_t b;
+        do {
+            b = read<uint8_t>();
+            value |= uint64_t(b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        return value;
+    }
+
+    string read_string() {
+        uint64_t len = read_varuint();
+        if (remaining() < len) {
+            throw runtime_error("row too short");
+        }
+        string value(reinterpret_cast<const char*>(pos), len);
+        pos += len;
+        return value;
+    }
+
+    //binary extension fields are only present if the row was written after they were added
+    bool has_extension() const { return remaining() > 0; }
+};
+
+string name_to_string(uint64_t value) {
+    static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+    string str(13, '.');
+    uint64_t tmp = value;
+    for (int i = 0; i <= 12; i++) {
+        char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+        str[12 - i] = c;
+        tmp >>= (i == 0 ? 4 : 5);
+    }
+    size_t last = str.find_last_not_of('.');
+    return last == string::npos ? "" : str.substr(0, last + 1);
+}
+
+string symbol_to_string(uint64_t value) {
+    string str = to_string(value & 0xff) + ",";
+    for (value >>= 8; value > 0; value >>= 8) {
+        str += char(value & 0xff);
+    }
+    return str;
+}
+
+//========== columns ==========
+
+class column {
+public:
+    column(const string& path) : out(path, ios::binary) {
+        if (!out) {
+            throw runtime_error("cannot open " + path);
+        }
+    }
+
+    virtual ~column() {}
+
+protected:
+    ofstream out;
+
+    void write_varuint(uint64_t value) {
+        do {
+            uint8_t b = value & 0x7f;
+            value >>= 7;
+            if (value > 0) {
+                b |= 0x80;
+            }
+            out.put(char(b));
+        } while (value > 0);
+    }
+};
+
+//integer column, varints
+class var_column : public column {
+public:
+    var_column(const string& path) : column(path + ".var.col") {}
+
+    void put(uint64_t value) { write_varuint(value); }
+};
+
+//amount column, zigzag varint deltas from the previous row
+class delta_column : public column {
+public:
+    delta_column(const string& path) : column(path + ".delta.col") {}
+
+    void put(int64_t value) {
+        int64_t delta = int64_t(uint64_t(value) - uint64_t(prev));
+        write_varuint((uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+        prev = value;
+    }
+
+private:
+    int64_t prev = 0;
+};
+
+//string column, varint length followed by the bytes
+class string_column : public column {
+public:
+    string_column(const string& path) : column(path + ".str.col") {}
+
+    void put(const string& value) {
+        write_varuint(value.size());
+        out.write(value.data(), value.size());
+    }
+};
+
+//name or symbol column, varint codes into a dictionary written one entry per line
+class dict_column : public column {
+public:
+    dict_column(const string& path, string (*to_str)(uint64_t)) :
+        column(path + ".dict.col"), dict(path + ".dict"), to_str(to_str) {}
+
+    void put(uint64_t value) {
+        auto itr = codes.find(value);
+        if (itr == codes.end()) {
+            itr = codes.emplace(value, uint64_t(codes.size())).first;
+            dict << to_str(value) << '\n';
+        }
+        write_varuint(itr->second);
+    }
+
+private:
+    ofstream dict;
+    string (*to_str)(uint64_t);
+    unordered_map<uint64_t, uint64_t> codes;
+};
+
+//asset split into a delta encoded amount and a dictionary encoded symbol
+struct asset_columns {
+    delta_column amount;
+    dict_column symbol;
+
+    asset_columns(const string& path) : amount(path + ".amount"), symbol(path + ".symbol", symbol_to_string) {}
+
+    void put(row_reader& r) {
+        amount.put(r.read<int64_t>());
+        symbol.put(r.read<uint64_t>());
+    }
+};
+
+//========== tables ==========
+
+class table_exporter {
+public:
+    virtual ~table_exporter() {}
+
+    virtual void decode(row_reader& r) = 0;
+};
+
+class project_exporter : public table_exporter {
+public:
+    project_exporter(const string& dir) :
+        extensions(dir + "/extensions"), project_name(dir + "/project_name", name_to_string),
+        category(dir + "/category", name_to_string), creator(dir + "/creator", name_to_string),
+        title(dir + "/title"), description(dir + "/description"), link(dir + "/link"),
+        requested(dir + "/requested"), received(dir + "/received"),
+        donations(dir + "/donations"), preorders(dir + "/preorders"),
+        begin_time(dir + "/begin_time"), end_time(dir + "/end_time"), status(dir + "/status"),
+        tag_count(dir + "/tag_count"), tags(dir + "/tags", name_to_string) {}
+
+    void decode(row_reader& r) override {
+        project_name.put(r.read<uint64_t>());
+        category.put(r.read<uint64_t>());
+        creator.put(r.read<uint64_t>());
+        title.put(r.read_string());
+        description.put(r.read_string());
+        link.put(r.read_string());
+        requested.put(r);
+        received.put(r);
+        donations.put(r.read<uint32_t>());
+        preorders.put(r.read<uint32_t>());
+        begin_time.put(r.read<uint32_t>());
+        end_time.put(r.read<uint32_t>());
+        status.put(r.read<uint8_t>());
+
+        bool has_tags = r.has_extension();
+        extensions.put(has_tags ? 1 : 0);
+
+        uint64_t count = has_tags ? r.read_varuint() : 0;
+        tag_count.put(count);
+        for (uint64_t i = 0; i < count; i++) {
+            tags.put(r.read<uint64_t>());
+        }
+    }
+
+private:
+    var_column extensions;
+    dict_column project_name, category, creator;
+    string_column title, description, link;
+    asset_columns requested, received;
+    var_column donations, preorders;
+    delta_column begin_time, end_time;
+    var_column status, tag_count;
+    dict_column tags;
+};
+
+class account_exporter : public table_exporter {
+public:
+    account_exporter(const string& dir) :
+        extensions(dir + "/extensions"), account_name(dir + "/account_name", name_to_string),
+        balance(dir + "/balance"), rewards(dir + "/rewards"),
+        bucket(dir + "/bucket"), last_refill(dir + "/last_refill"), suspended(dir + "/suspended") {}
+
+    void decode(row_reader& r) override {
+        account_name.put(r.read<uint64_t>());
+        balance.put(r);
+        rewards.put(r);
+
+        //extensions are appended in order, so a row holds a prefix of them
+        uint64_t count = 0;
+        uint16_t bucket_value = 0;
+        uint32_t last_refill_value = 0;
+        uint8_t suspended_value = 0;
+
+        if (r.has_extension()) {
+            bucket_value = r.read<uint16_t>();
+            count++;
+        }
+        if (r.has_extension()) {
+            last_refill_value = r.read<uint32_t>();
+            count++;
+        }
+        if (r.has_extension()) {
+            suspended_value = r.read<uint8_t>();
+            count++;
+        }
+
+        bucket.put(bucket_value);
+        last_refill.put(last_refill_value);
+        suspended.put(suspended_value);
+        extensions.put(count);
+    }
+
+private:
+    var_column extensions;
+    dict_column account_name;
+    asset_columns balance, rewards;
+    var_column bucket;
+    delta_column last_refill;
+    var_column suspended;
+};
+
+class donation_exporter : public table_exporter {
+public:
+    donation_exporter(const string& dir) :
+        donation_id(dir + "/donation_id"),
+        donor(dir + "/donor", name_to_string), project_name(dir + "/project_name", name_to_string),
+        total(dir + "/total") {}
+
+    void decode(row_reader& r) override {
+        donation_id.put(int64_t(r.read<uint64_t>()));
+        donor.put(r.read<uint64_t>());
+        project_name.put(r.read<uint64_t>());
+        total.put(r);
+    }
+
+private:
+    delta_column donation_id;
+    dict_column donor, project_name;
+    asset_columns total;
+};
+
+//========== input ==========
+
+//yields hex rows from the rows arrays of concatenated cleos json pages, or from plain lines
+class row_source {
+public:
+    row_source(istream& in) : in(in) {
+        in >> ws;
+        json = in.peek() == '{';
+        if (json && !skip_to_rows()) {
+            throw runtime_error("no rows array in json input");
+        }
+    }
+
+    bool next(string& hex) {
+        return json ? next_json(hex) : next_line(hex);
+    }
+
+private:
+    istream& in;
+    bool json;
+
+    //reads up to the closing quote of a json string
+    string read_quoted() {
+        string str;
+        char c;
+        while (in.get(c) && c != '"') {
+            str += c;
+        }
+        return str;
+    }
+
+    //moves past the opening bracket of the next rows array, false at end of input
+    bool skip_to_rows() {
+        char c;
+        while (in.get(c)) {
+            if (c == '"' && read_quoted() == "rows") {
+                while (in.get(c) && c != '[') {}
+                return bool(in);
+            }
+        }
+        return false;
+    }
+
+    bool next_json(string& hex) {
+        char c;
+        while (in.get(c)) {
+            if (c == '"') {
+                hex = read_quoted();
+                return true;
+            } else if (c == '{') {
+                throw runtime_error("rows are not binary, use cleos get table --binary");
+            } else if (c == ']' && !skip_to_rows()) {
+                return false;
+            }
+        }
+        throw runtime_error("unterminated rows array");
+    }
+
+    bool next_line(string& hex) {
+        while (getline(in, hex)) {
+            size_t first = hex.find_first_not_of(" \t");
+            size_t last = hex.find_last_not_of(" \t\r");
+            if (first != string::npos) {
+                hex = hex.substr(first, last - first + 1);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+//========== main ==========
+
+bool hex_to_bytes(const string& hex, vector<uint8_t>& bytes) {
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+
+    bytes.resize(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        int hi = nibble(hex[2 * i]);
+        int lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        bytes[i] = uint8_t((hi << 4) | lo);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " <projects|accounts|donations> <out_dir> [rows_file]" << endl;
+        return 1;
+    }
+
+    string table = argv[1];
+    string dir = argv[2];
+
+    try {
+        filesystem::create_directories(dir);
+
+        unique_ptr<table_exporter> exporter;
+        if (table == "projects") {
+            exporter.reset(new project_exporter(dir));
+        } else if (table == "accounts") {
+            exporter.reset(new account_exporter(dir));
+        } else if (table == "donations") {
+            exporter.reset(new donation_exporter(dir));
+        } else {
+            cerr << "unknown table " << table << endl;
+            return 1;
+        }
+
+        ifstream file;
+        if (argc > 3) {
+            file.open(argv[3]);
+            if (!file) {
+                cerr << "cannot open " << argv[3] << endl;
+                return 1;
+            }
+        }
+        istream& in = argc > 3 ? file : cin;
+
+        row_source source(in);
+        string line;
+        vector<uint8_t> bytes;
+        uint64_t rows = 0;
+        auto start = chrono::steady_clock::now();
+
+        while (source.next(line)) {
+            if (!hex_to_bytes(line, bytes)) {
+                throw runtime_error("invalid hex on row " + to_string(rows + 1));
+            }
+
+            row_reader r{bytes.data(), bytes.data() + bytes.size()};
+            exporter->decode(r);
+            rows++;
+
+            if (r.remaining() > 0) {
+                throw runtime_error("row " + to_string(rows) + " has " + to_string(r.remaining()) + 
+                    " bytes left over, layout does not match");
+            }
+        }
+
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cerr << rows << " rows in " << secs << " s, " << uint64_t(secs > 0 ? rows / secs : 0) << " rows/s" << endl;
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}